@@ -0,0 +1,90 @@
+/*
+ * author: Luis Enrique Arias Curbelo
+ * repo:   https://github.com/larias95/shunting_yard
+ */
+
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+#include "lexer.hpp"
+#include "my_context.hpp"
+#include "numeric.hpp"
+#include "parser.hpp"
+
+using namespace sy;
+
+/*
+ * Times to_rpn and rpn_eval for every numeric instantiation over the same
+ * expressions, which are valid (and overflow free) for all of them.
+ */
+
+typedef chrono::steady_clock steady_clock_t;
+
+const vector<string> EXPRESSIONS {
+    "1 + 2 * 3 - 4 / 2",
+    "max(3, 4) ^ 2 + min(7, 9) % 4",
+    "(12 + 30) * (5 - 3) / 7",
+    "10! / 9! + abs(~5)",
+    "sqrt(144) + sqrt(2)",
+    "sin(1) + cos(2) + exp(3)",
+    "2 _ 1024 + log(100)",
+};
+
+template <typename T>
+void bench(size_t iterations) {
+    ParsingContext<T>* context = get_context<T>();
+
+    vector<vector<token_t>> tokens(EXPRESSIONS.size());
+    vector<vector<token_t>> rpns(EXPRESSIONS.size());
+
+    for (size_t i = 0; i < EXPRESSIONS.size(); ++i)
+        tokenize(EXPRESSIONS[i], tokens[i]);
+
+    steady_clock_t::time_point start = steady_clock_t::now();
+
+    for (size_t n = 0; n < iterations; ++n)
+        for (size_t i = 0; i < tokens.size(); ++i) {
+            rpns[i].clear();
+            to_rpn(tokens[i], context, rpns[i]);
+        }
+
+    steady_clock_t::time_point middle = steady_clock_t::now();
+
+    vector<T> results;
+    T checksum = 0;
+
+    for (size_t n = 0; n < iterations; ++n)
+        for (const vector<token_t>& rpn : rpns) {
+            results.clear();
+            rpn_eval(rpn, context, results);
+            checksum += results[0];
+        }
+
+    steady_clock_t::time_point end = steady_clock_t::now();
+
+    double count = double(iterations) * EXPRESSIONS.size();
+    double to_rpn_ns = chrono::duration<double, nano>(middle - start).count() / count;
+    double rpn_eval_ns = chrono::duration<double, nano>(end - middle).count() / count;
+
+    cout << setw(12) << left << numeric_traits<T>::name()
+         << "to_rpn: " << setw(10) << fixed << setprecision(1) << to_rpn_ns << " ns/expr   "
+         << "rpn_eval: " << setw(10) << rpn_eval_ns << " ns/expr   "
+         << "(checksum " << checksum << ")" << endl;
+}
+
+int main(int argc, char* argv[]) {
+    size_t iterations = (argc > 1) ? stoul(argv[1]) : 20000;
+
+    bench<float>(iterations);
+    bench<double>(iterations);
+    bench<long double>(iterations);
+    bench<int64_t>(iterations);
+
+    return 0;
+}
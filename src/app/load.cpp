@@ -0,0 +1,197 @@
+/*
+ * author: Luis Enrique Arias Curbelo
+ * repo:   https://github.com/larias95/shunting_yard
+ */
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+using namespace std;
+
+#include "protocol.hpp"
+
+/*
+ * Load generator for the server mode. Every connection runs on its own thread
+ * and keeps up to `depth` requests in flight, cycling through a fixed set of
+ * expressions, and records the latency of each request.
+ */
+
+typedef chrono::steady_clock steady_clock_t;
+
+const vector<string> EXPRESSIONS {
+    "1 + 2 * 3",
+    "sqrt(2) ^ 2",
+    "5! / (2 + 3)",
+    "sin(pi / 4) * cos(pi / 4)",
+    "max(e, phi) _ 10",
+};
+
+int connect_to(const string& path) {
+    sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+
+    if (path.size() >= sizeof(address.sun_path))
+        throw runtime_error("Socket path " + path + " is too long.");
+
+    strcpy(address.sun_path, path.c_str());
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+
+    if (fd < 0 || connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0)
+        throw runtime_error(string("connect: ") + strerror(errno));
+
+    return fd;
+}
+
+void send_all(int fd, const string& buffer) {
+    size_t offset = 0;
+
+    while (offset < buffer.size()) {
+        ssize_t count = send(fd, buffer.data() + offset, buffer.size() - offset, MSG_NOSIGNAL);
+
+        if (count < 0 && errno != EINTR)
+            throw runtime_error(string("send: ") + strerror(errno));
+
+        if (count > 0)
+            offset += count;
+    }
+}
+
+void run_connection(const string& path, size_t requests, size_t depth, vector<double>& latencies, uint64_t& errors) {
+    int fd = connect_to(path);
+
+    vector<steady_clock_t::time_point> sent_at(requests);
+    string output;
+    string input;
+    char chunk[64 * 1024];
+
+    size_t sent = 0;
+    size_t received = 0;
+
+    while (received < requests) {
+        for (; sent < requests && sent - received < depth; ++sent) {
+            append_request(output, sent, EXPRESSIONS[sent % EXPRESSIONS.size()]);
+            sent_at[sent] = steady_clock_t::now();
+        }
+
+        if (!output.empty()) {
+            send_all(fd, output);
+            output.clear();
+        }
+
+        ssize_t count = recv(fd, chunk, sizeof(chunk), 0);
+
+        if (count == 0)
+            throw runtime_error("Server closed the connection.");
+
+        if (count < 0) {
+            if (errno == EINTR)
+                continue;
+
+            throw runtime_error(string("recv: ") + strerror(errno));
+        }
+
+        input.append(chunk, count);
+
+        steady_clock_t::time_point now = steady_clock_t::now();
+        size_t offset = 0;
+        uint32_t id;
+        string body;
+
+        while (next_frame(input, offset, id, body)) {
+            if (id >= requests || body.empty())
+                throw runtime_error("Unexpected response " + to_string(id) + ".");
+
+            if (static_cast<uint8_t>(body[0]) != STATUS_OK)
+                ++errors;
+
+            latencies.push_back(chrono::duration<double, micro>(now - sent_at[id]).count());
+            ++received;
+        }
+
+        input.erase(0, offset);
+    }
+
+    close(fd);
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        cerr << "usage: " << argv[0] << " <socket path> [connections=4] [requests per connection=100000] [pipeline depth=64]" << endl;
+        return 1;
+    }
+
+    string path = argv[1];
+    size_t connections = (argc > 2) ? stoul(argv[2]) : 4;
+    size_t requests = (argc > 3) ? stoul(argv[3]) : 100000;
+    size_t depth = (argc > 4) ? max<size_t>(1, stoul(argv[4])) : 64;
+
+    vector<vector<double>> latencies(connections);
+    vector<uint64_t> errors(connections, 0);
+    vector<string> failures(connections);
+    vector<thread> workers;
+
+    steady_clock_t::time_point start = steady_clock_t::now();
+
+    for (size_t i = 0; i < connections; ++i)
+        workers.push_back(thread([&, i]() {
+            try {
+                latencies[i].reserve(requests);
+                run_connection(path, requests, depth, latencies[i], errors[i]);
+            }
+            catch (exception& ex) {
+                failures[i] = ex.what();
+            }
+        }));
+
+    for (thread& worker : workers)
+        worker.join();
+
+    double elapsed = chrono::duration<double>(steady_clock_t::now() - start).count();
+
+    for (const string& failure : failures)
+        if (!failure.empty()) {
+            cerr << failure << endl;
+            return 1;
+        }
+
+    vector<double> all;
+    uint64_t error_count = 0;
+
+    for (size_t i = 0; i < connections; ++i) {
+        all.insert(all.end(), latencies[i].begin(), latencies[i].end());
+        error_count += errors[i];
+    }
+
+    if (all.empty()) {
+        cout << "no requests sent" << endl;
+        return 0;
+    }
+
+    sort(all.begin(), all.end());
+
+    auto percentile = [&all](double p) {
+        return all[min(all.size() - 1, static_cast<size_t>(p * all.size()))];
+    };
+
+    cout << "requests:   " << all.size() << " (" << error_count << " errors)" << endl;
+    cout << "throughput: " << all.size() / elapsed << " req/s" << endl;
+    cout << "p50:        " << percentile(0.50) << " us" << endl;
+    cout << "p99:        " << percentile(0.99) << " us" << endl;
+
+    return 0;
+}
@@ -3,6 +3,7 @@
  * repo:   https://github.com/larias95/shunting_yard
  */
 
+#include <cstdint>
 #include <exception>
 #include <iostream>
 #include <string>
@@ -22,25 +23,31 @@ void print_tokens(const vector<token_t>& tokens) {
     cout << endl;
 }
 
-int main() {
-    ParsingContext* context = get_context();
+template <typename T>
+void run() {
+    ParsingContext<T>* context = get_context<T>();
 
     string line;
     vector<token_t> tokens;
     vector<token_t> rpn;
-    vector<double> results;
+    vector<T> results;
 
     while (cout << ">> ", getline(cin, line), line != "exit") {
         try {
             tokenize(line, tokens);
             // print_tokens(tokens);
 
-            to_rpn(tokens, context, rpn);
-            // print_tokens(rpn);
+            if (is_definition(tokens))
+                cout << define(tokens, context) << " defined" << endl;
 
-            rpn_eval(rpn, context, results);
+            else {
+                to_rpn(tokens, context, rpn);
+                // print_tokens(rpn);
 
-            cout << results[0] << endl;
+                rpn_eval(rpn, context, results);
+
+                cout << results[0] << endl;
+            }
         }
         catch (exception& ex) {
             cout << ex.what() << endl;
@@ -50,6 +57,23 @@ int main() {
         rpn.clear();
         results.clear();
     }
+}
+
+int main(int argc, char* argv[]) {
+    string type = (argc > 1) ? argv[1] : "double";
+
+    if (type == "float")
+        run<float>();
+    else if (type == "double")
+        run<double>();
+    else if (type == "ldouble")
+        run<long double>();
+    else if (type == "int64")
+        run<int64_t>();
+    else {
+        cout << "Unknown numeric type " << type << " (expected float, double, ldouble or int64)." << endl;
+        return 1;
+    }
 
     return 0;
 }
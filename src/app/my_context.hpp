@@ -5,7 +5,11 @@
 
 #pragma once
 
+#include <algorithm>
 #include <cmath>
+#include <limits>
+#include <stdexcept>
+#include <type_traits>
 #include <vector>
 
 using namespace std;
@@ -14,112 +18,295 @@ using namespace std;
 
 using namespace sy;
 
+/*
+ * exact arithmetic: floating point types use the plain operations, while
+ * integral types throw instead of overflowing or trapping.
+ */
+
+inline void _check_overflow(bool overflow) {
+    if (overflow)
+        throw runtime_error("Integer overflow.");
+}
+
+template <typename T>
+inline T _narrow(long double x) {
+    // NaN fails both comparisons
+    _check_overflow(!(x >= static_cast<long double>(numeric_limits<T>::min()) &&
+                      x < -static_cast<long double>(numeric_limits<T>::min())));
+    return static_cast<T>(x);
+}
+
+/*
+ * real functions: floating point types call `f` on their own type, integral
+ * types go through long double and are range-checked on the way back.
+ */
+
+template <typename T, typename F>
+inline T _real(F f, T a, false_type) {
+    return f(a);
+}
+
+template <typename T, typename F>
+inline T _real(F f, T a, true_type) {
+    return _narrow<T>(f(static_cast<long double>(a)));
+}
+
+template <typename T, typename F>
+inline T _real(F f, T a, T b, false_type) {
+    return f(a, b);
+}
+
+template <typename T, typename F>
+inline T _real(F f, T a, T b, true_type) {
+    return _narrow<T>(f(static_cast<long double>(a), static_cast<long double>(b)));
+}
+
+template <typename T>
+inline T _negate(T a, false_type) {
+    return -a;
+}
+
+template <typename T>
+inline T _negate(T a, true_type) {
+    T result;
+    _check_overflow(__builtin_sub_overflow(T(0), a, &result));
+    return result;
+}
+
+template <typename T>
+inline T _plus(T a, T b, false_type) {
+    return a + b;
+}
+
+template <typename T>
+inline T _plus(T a, T b, true_type) {
+    T result;
+    _check_overflow(__builtin_add_overflow(a, b, &result));
+    return result;
+}
+
+template <typename T>
+inline T _minus(T a, T b, false_type) {
+    return a - b;
+}
+
+template <typename T>
+inline T _minus(T a, T b, true_type) {
+    T result;
+    _check_overflow(__builtin_sub_overflow(a, b, &result));
+    return result;
+}
+
+template <typename T>
+inline T _times(T a, T b, false_type) {
+    return a * b;
+}
+
+template <typename T>
+inline T _times(T a, T b, true_type) {
+    T result;
+    _check_overflow(__builtin_mul_overflow(a, b, &result));
+    return result;
+}
+
+template <typename T>
+inline void _check_divisor(T a, T b, true_type) {
+    if (b == 0)
+        throw runtime_error("Division by zero.");
+
+    _check_overflow(a == numeric_limits<T>::min() && b == -1);
+}
+
+template <typename T>
+inline T _quotient(T a, T b, false_type) {
+    return a / b;
+}
+
+template <typename T>
+inline T _quotient(T a, T b, true_type) {
+    _check_divisor(a, b, true_type());
+    return a / b;
+}
+
+template <typename T>
+inline T _remainder(T a, T b, false_type) {
+    return std::fmod(a, b);
+}
+
+template <typename T>
+inline T _remainder(T a, T b, true_type) {
+    _check_divisor(a, b, true_type());
+    return a % b;
+}
+
+template <typename T>
+inline T _power(T a, T b, false_type) {
+    return std::pow(a, b);
+}
+
+template <typename T>
+inline T _power(T a, T b, true_type) {
+    if (b < 0)
+        throw runtime_error("Negative integer exponent.");
+
+    T result = 1;
+
+    // exponentiation by squaring, only squaring while bits remain
+    for (; b > 0; b >>= 1) {
+        if (b & 1)
+            result = _times(result, a, true_type());
+        if (b > 1)
+            a = _times(a, a, true_type());
+    }
+
+    return result;
+}
+
+template <typename T>
+inline T _gamma_1(T a, false_type) {
+    return std::tgamma(a + 1);
+}
+
+template <typename T>
+inline T _gamma_1(T a, true_type) {
+    if (a < 0)
+        throw runtime_error("Factorial of a negative integer.");
+
+    T result = 1;
+
+    for (T i = 2; i <= a; ++i)
+        result = _times(result, i, true_type());
+
+    return result;
+}
+
 /* functions: */
 
-inline double _abs(const vector<double>& args) {
-    return std::abs(args[0]);
+template <typename T>
+inline T _abs(const vector<T>& args) {
+    return (args[0] < 0) ? _negate(args[0], is_integral<T>()) : args[0];
 }
 
-inline double _sqrt(const vector<double>& args) {
-    return std::sqrt(args[0]);
+template <typename T>
+inline T _sqrt(const vector<T>& args) {
+    return _real([](auto x) { return std::sqrt(x); }, args[0], is_integral<T>());
 }
 
-inline double _exp(const vector<double>& args) {
-    return std::exp(args[0]);
+template <typename T>
+inline T _exp(const vector<T>& args) {
+    return _real([](auto x) { return std::exp(x); }, args[0], is_integral<T>());
 }
 
-inline double _log(const vector<double>& args) {
-    return std::log(args[0]);
+template <typename T>
+inline T _log(const vector<T>& args) {
+    return _real([](auto x) { return std::log(x); }, args[0], is_integral<T>());
 }
 
-inline double _sin(const vector<double>& args) {
-    return std::sin(args[0]);
+template <typename T>
+inline T _sin(const vector<T>& args) {
+    return _real([](auto x) { return std::sin(x); }, args[0], is_integral<T>());
 }
 
-inline double _cos(const vector<double>& args) {
-    return std::cos(args[0]);
+template <typename T>
+inline T _cos(const vector<T>& args) {
+    return _real([](auto x) { return std::cos(x); }, args[0], is_integral<T>());
 }
 
-inline double _tan(const vector<double>& args) {
-    return std::tan(args[0]);
+template <typename T>
+inline T _tan(const vector<T>& args) {
+    return _real([](auto x) { return std::tan(x); }, args[0], is_integral<T>());
 }
 
-inline double _min(const vector<double>& args) {
+template <typename T>
+inline T _min(const vector<T>& args) {
     return std::min(args[0], args[1]);
 }
 
-inline double _max(const vector<double>& args) {
+template <typename T>
+inline T _max(const vector<T>& args) {
     return std::max(args[0], args[1]);
 }
 
 /* operators: */
 
-inline double _neg(const vector<double>& args) {
-    return -args[0];
+template <typename T>
+inline T _neg(const vector<T>& args) {
+    return _negate(args[0], is_integral<T>());
 }
 
-inline double _add(const vector<double>& args) {
-    return args[0] + args[1];
+template <typename T>
+inline T _add(const vector<T>& args) {
+    return _plus(args[0], args[1], is_integral<T>());
 }
 
-inline double _sub(const vector<double>& args) {
-    return args[0] - args[1];
+template <typename T>
+inline T _sub(const vector<T>& args) {
+    return _minus(args[0], args[1], is_integral<T>());
 }
 
-inline double _mul(const vector<double>& args) {
-    return args[0] * args[1];
+template <typename T>
+inline T _mul(const vector<T>& args) {
+    return _times(args[0], args[1], is_integral<T>());
 }
 
-inline double _div(const vector<double>& args) {
-    return args[0] / args[1];
+template <typename T>
+inline T _div(const vector<T>& args) {
+    return _quotient(args[0], args[1], is_integral<T>());
 }
 
-inline double _rem(const vector<double>& args) {
-    return std::fmod(args[0], args[1]);
+template <typename T>
+inline T _rem(const vector<T>& args) {
+    return _remainder(args[0], args[1], is_integral<T>());
 }
 
-inline double _pow(const vector<double>& args) {
-    return std::pow(args[0], args[1]);
+template <typename T>
+inline T _pow(const vector<T>& args) {
+    return _power(args[0], args[1], is_integral<T>());
 }
 
-inline double _log_b(const vector<double>& args) {
-    return std::log(args[1]) / std::log(args[0]);
+template <typename T>
+inline T _log_b(const vector<T>& args) {
+    return _real([](auto b, auto x) { return std::log(x) / std::log(b); }, args[0], args[1], is_integral<T>());
 }
 
-inline double _factorial(const vector<double>& args) {
-    return std::tgamma(args[0] + 1);
+template <typename T>
+inline T _factorial(const vector<T>& args) {
+    return _gamma_1(args[0], is_integral<T>());
 }
 
-inline ParsingContext* get_context() {
+template <typename T>
+inline ParsingContext<T>* get_context() {
     
-    ParsingContext* context = (new ParsingContext)
-
-    // constants:
-    ->set("e", 2.718281828459045235360287471352662498L)
-    ->set("phi", 1.618033988749894848204586834365638118L)
-    ->set("pi", 3.141592653589793238462643383279502884L)
+    ParsingContext<T>* context = (new ParsingContext<T>)
 
     // functions:
-    ->set("abs", Evaluable_t::Function(1, _abs))
-    ->set("sqrt", Evaluable_t::Function(1, _sqrt))
-    ->set("exp", Evaluable_t::Function(1, _exp))
-    ->set("log", Evaluable_t::Function(1, _log))
-    ->set("sin", Evaluable_t::Function(1, _sin))
-    ->set("cos", Evaluable_t::Function(1, _cos))
-    ->set("tan", Evaluable_t::Function(1, _tan))
-    ->set("min", Evaluable_t::Function(2, _min))
-    ->set("max", Evaluable_t::Function(2, _max))
+    ->set("abs", Evaluable_t<T>::Function(1, _abs<T>))
+    ->set("sqrt", Evaluable_t<T>::Function(1, _sqrt<T>))
+    ->set("exp", Evaluable_t<T>::Function(1, _exp<T>))
+    ->set("log", Evaluable_t<T>::Function(1, _log<T>))
+    ->set("sin", Evaluable_t<T>::Function(1, _sin<T>))
+    ->set("cos", Evaluable_t<T>::Function(1, _cos<T>))
+    ->set("tan", Evaluable_t<T>::Function(1, _tan<T>))
+    ->set("min", Evaluable_t<T>::Function(2, _min<T>))
+    ->set("max", Evaluable_t<T>::Function(2, _max<T>))
 
     // operators:
-    ->set("~", Operator_t::Unary(10, Operator_t::position_t::PREFIX, _neg))
-    ->set("+", Operator_t::Binary(8, Operator_t::assoc_t::LEFT, _add))
-    ->set("-", Operator_t::Binary(8, Operator_t::assoc_t::LEFT, _sub))
-    ->set("*", Operator_t::Binary(9, Operator_t::assoc_t::LEFT, _mul))
-    ->set("/", Operator_t::Binary(9, Operator_t::assoc_t::LEFT, _div))
-    ->set("%", Operator_t::Binary(9, Operator_t::assoc_t::LEFT, _rem))
-    ->set("^", Operator_t::Binary(10, Operator_t::assoc_t::RIGHT, _pow))
-    ->set("_", Operator_t::Binary(10, Operator_t::assoc_t::RIGHT, _log_b))
-    ->set("!", Operator_t::Unary(11, Operator_t::position_t::POSTFIX, _factorial));
+    ->set("~", Operator_t<T>::Unary(10, Operator_t<T>::position_t::PREFIX, _neg<T>))
+    ->set("+", Operator_t<T>::Binary(8, Operator_t<T>::assoc_t::LEFT, _add<T>))
+    ->set("-", Operator_t<T>::Binary(8, Operator_t<T>::assoc_t::LEFT, _sub<T>))
+    ->set("*", Operator_t<T>::Binary(9, Operator_t<T>::assoc_t::LEFT, _mul<T>))
+    ->set("/", Operator_t<T>::Binary(9, Operator_t<T>::assoc_t::LEFT, _div<T>))
+    ->set("%", Operator_t<T>::Binary(9, Operator_t<T>::assoc_t::LEFT, _rem<T>))
+    ->set("^", Operator_t<T>::Binary(10, Operator_t<T>::assoc_t::RIGHT, _pow<T>))
+    ->set("_", Operator_t<T>::Binary(10, Operator_t<T>::assoc_t::RIGHT, _log_b<T>))
+    ->set("!", Operator_t<T>::Unary(11, Operator_t<T>::position_t::POSTFIX, _factorial<T>));
+
+    // constants (irrational, so an integral context leaves them out rather than truncating them):
+    if (!is_integral<T>::value)
+        context
+        ->set("e", static_cast<T>(2.718281828459045235360287471352662498L))
+        ->set("phi", static_cast<T>(1.618033988749894848204586834365638118L))
+        ->set("pi", static_cast<T>(3.141592653589793238462643383279502884L));
 
     return context;
 }
@@ -0,0 +1,95 @@
+/*
+ * author: Luis Enrique Arias Curbelo
+ * repo:   https://github.com/larias95/shunting_yard
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+/*
+ * Framing used by the server mode over a Unix domain socket.
+ * Integers are sent in the host byte order (both ends share the machine).
+ *
+ * request:  u32 length | u32 id | expression bytes
+ * response: u32 length | u32 id | u8 status | payload
+ *
+ * `length` counts the bytes following it. The payload is an 8 byte double
+ * when status is STATUS_OK, or the error message when it is STATUS_ERROR.
+ * Responses carry the id of their request, so many requests may be in
+ * flight per connection and the server may answer them in any order.
+ */
+
+const uint8_t STATUS_OK = 0;
+const uint8_t STATUS_ERROR = 1;
+
+/*
+ * Longest expression the server evaluates; longer ones are answered with an
+ * error without being tokenized, which keeps every request to a few
+ * milliseconds on the single-threaded server.
+ */
+const uint32_t MAX_EXPRESSION_LENGTH = 4 << 10;
+
+/*
+ * Longest frame either side accepts. It leaves room for error messages that
+ * quote a token of a maximal expression; a longer frame is a protocol error.
+ */
+const uint32_t MAX_FRAME_LENGTH = 8 << 10;
+
+inline void append_u32(string& buffer, uint32_t value) {
+    buffer.append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+inline uint32_t read_u32(const char* data) {
+    uint32_t value;
+    memcpy(&value, data, sizeof(value));
+    return value;
+}
+
+inline void append_request(string& buffer, uint32_t id, const string& expression) {
+    append_u32(buffer, sizeof(id) + expression.size());
+    append_u32(buffer, id);
+    buffer.append(expression);
+}
+
+inline void append_response(string& buffer, uint32_t id, double value) {
+    append_u32(buffer, sizeof(id) + 1 + sizeof(value));
+    append_u32(buffer, id);
+    buffer.push_back(static_cast<char>(STATUS_OK));
+    buffer.append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+inline void append_error(string& buffer, uint32_t id, const string& message) {
+    append_u32(buffer, sizeof(id) + 1 + message.size());
+    append_u32(buffer, id);
+    buffer.push_back(static_cast<char>(STATUS_ERROR));
+    buffer.append(message);
+}
+
+/*
+ * Extracts the complete frame starting at `offset` in `buffer` and moves `offset` past it.
+ * Returns false when more bytes are needed; throws on an invalid frame length.
+ */
+inline bool next_frame(const string& buffer, size_t& offset, uint32_t& id, string& body) {
+    if (buffer.size() - offset < 2 * sizeof(uint32_t))
+        return false;
+
+    uint32_t length = read_u32(buffer.data() + offset);
+
+    if (length < sizeof(uint32_t) || length > MAX_FRAME_LENGTH)
+        throw runtime_error("Invalid frame length " + to_string(length) + ".");
+
+    if (buffer.size() - offset - sizeof(length) < length)
+        return false;
+
+    id = read_u32(buffer.data() + offset + sizeof(length));
+    body.assign(buffer, offset + 2 * sizeof(uint32_t), length - sizeof(uint32_t));
+    offset += sizeof(length) + length;
+
+    return true;
+}
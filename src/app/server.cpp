@@ -0,0 +1,352 @@
+/*
+ * author: Luis Enrique Arias Curbelo
+ * repo:   https://github.com/larias95/shunting_yard
+ */
+
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <iostream>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+using namespace std;
+
+#include "lexer.hpp"
+#include "my_context.hpp"
+#include "parser.hpp"
+#include "protocol.hpp"
+
+using namespace sy;
+
+/*
+ * Long-running server mode: a single-threaded poll() loop over non-blocking
+ * Unix domain sockets. Each iteration reads every complete request frame that
+ * arrived on any connection, groups them by expression text, evaluates each
+ * distinct expression once and queues the answer for every request that asked it.
+ */
+
+/*
+ * A connection stops being read while this many response bytes are waiting to
+ * be written, so a client that pipelines without reading cannot grow them unbounded.
+ */
+const size_t MAX_PENDING_OUTPUT = 4 << 20;
+
+/*
+ * How long the listener is left alone after accept() ran out of descriptors
+ * (or memory), instead of polling a listener that stays readable.
+ */
+const int ACCEPT_BACKOFF_MS = 100;
+
+/*
+ * Bytes read from a connection per loop iteration, so a fast writer can neither
+ * starve the others nor queue more than one iteration's worth of responses
+ * past MAX_PENDING_OUTPUT. poll() reports the rest on the next iteration.
+ */
+const size_t MAX_READ_PER_ITERATION = 64 << 10;
+
+struct connection_t {
+    int    fd;
+    string input;
+    string output;
+    bool   eof;    // peer shut down its side: answer what is pending, then close
+    bool   closed; // I/O or framing error: drop the connection
+
+    bool wants_input() const {
+        return !eof && output.size() < MAX_PENDING_OUTPUT;
+    }
+};
+
+struct request_t {
+    size_t   connection;
+    uint32_t id;
+};
+
+typedef chrono::steady_clock steady_clock_t;
+
+volatile sig_atomic_t stop_requested = 0;
+
+void on_signal(int) {
+    stop_requested = 1;
+}
+
+void set_non_blocking(int fd) {
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+}
+
+int listen_on(const string& path) {
+    sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+
+    if (path.size() >= sizeof(address.sun_path))
+        throw runtime_error("Socket path " + path + " is too long.");
+
+    strcpy(address.sun_path, path.c_str());
+
+    // only a stale socket may be replaced, never an ordinary file
+    struct stat status;
+
+    if (lstat(path.c_str(), &status) == 0) {
+        if (!S_ISSOCK(status.st_mode))
+            throw runtime_error(path + " exists and is not a socket.");
+
+        unlink(path.c_str());
+    }
+    else if (errno != ENOENT)
+        throw runtime_error(string("lstat: ") + strerror(errno));
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+
+    if (fd < 0)
+        throw runtime_error(string("socket: ") + strerror(errno));
+
+    if (bind(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0 || listen(fd, SOMAXCONN) < 0) {
+        string error = string("bind/listen: ") + strerror(errno);
+        close(fd);
+        throw runtime_error(error);
+    }
+
+    set_non_blocking(fd);
+    return fd;
+}
+
+void read_requests(
+    connection_t& connection,
+    size_t index,
+    unordered_map<string, vector<request_t>>& batch
+) {
+    char chunk[16 * 1024];
+    size_t total = 0;
+
+    while (total < MAX_READ_PER_ITERATION) {
+        ssize_t count = recv(connection.fd, chunk, sizeof(chunk), 0);
+
+        if (count > 0) {
+            connection.input.append(chunk, count);
+            total += count;
+        }
+
+        else {
+            if (count == 0)
+                connection.eof = true;
+            else if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)
+                connection.closed = true;
+
+            if (count == 0 || errno != EINTR)
+                break;
+        }
+    }
+
+    size_t offset = 0;
+    uint32_t id;
+    string expression;
+
+    try {
+        while (next_frame(connection.input, offset, id, expression))
+            batch[expression].push_back(request_t { index, id });
+    }
+    catch (exception& ex) {
+        cerr << ex.what() << endl;
+        connection.closed = true;
+    }
+
+    connection.input.erase(0, offset);
+}
+
+void write_responses(connection_t& connection) {
+    size_t offset = 0;
+
+    while (offset < connection.output.size()) {
+        ssize_t count = send(connection.fd, connection.output.data() + offset,
+                             connection.output.size() - offset, MSG_NOSIGNAL);
+
+        if (count > 0)
+            offset += count;
+
+        else {
+            if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)
+                connection.closed = true;
+
+            if (errno != EINTR)
+                break;
+        }
+    }
+
+    connection.output.erase(0, offset);
+}
+
+void evaluate_batch(
+    const unordered_map<string, vector<request_t>>& batch,
+    const ParsingContext<double>* context,
+    vector<connection_t>& connections
+) {
+    vector<token_t> tokens;
+    vector<token_t> rpn;
+    vector<double> results;
+
+    for (auto& entry : batch) {
+        string error;
+
+        try {
+            if (entry.first.size() > MAX_EXPRESSION_LENGTH)
+                throw runtime_error("Expression longer than " + to_string(MAX_EXPRESSION_LENGTH) + " bytes.");
+
+            tokenize(entry.first, tokens);
+            to_rpn(tokens, context, rpn);
+            rpn_eval(rpn, context, results);
+        }
+        catch (exception& ex) {
+            error = ex.what();
+        }
+
+        for (const request_t& request : entry.second) {
+            connection_t& connection = connections[request.connection];
+
+            if (connection.closed)
+                continue;
+
+            if (error.empty())
+                append_response(connection.output, request.id, results[0]);
+            else
+                append_error(connection.output, request.id, error);
+        }
+
+        tokens.clear();
+        rpn.clear();
+        results.clear();
+    }
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        cerr << "usage: " << argv[0] << " <socket path>" << endl;
+        return 1;
+    }
+
+    string path = argv[1];
+    ParsingContext<double>* context = get_context<double>();
+
+    signal(SIGINT, on_signal);
+    signal(SIGTERM, on_signal);
+
+    int listener;
+
+    try {
+        listener = listen_on(path);
+    }
+    catch (exception& ex) {
+        cerr << ex.what() << endl;
+        return 1;
+    }
+
+    vector<connection_t> connections;
+    vector<pollfd> fds;
+    unordered_map<string, vector<request_t>> batch;
+
+    uint64_t request_count = 0;
+    uint64_t evaluation_count = 0;
+
+    bool accepting_paused = false;
+    steady_clock_t::time_point accept_resume_at;
+
+    while (!stop_requested) {
+        int timeout = -1;
+
+        if (accepting_paused) {
+            auto remaining = chrono::duration_cast<chrono::milliseconds>(accept_resume_at - steady_clock_t::now()).count();
+
+            if (remaining > 0)
+                timeout = remaining;
+            else
+                accepting_paused = false;
+        }
+
+        fds.clear();
+        fds.push_back(pollfd { listener, short(accepting_paused ? 0 : POLLIN), 0 });
+
+        for (const connection_t& connection : connections) {
+            short events = (connection.wants_input() ? POLLIN : 0) | (connection.output.empty() ? 0 : POLLOUT);
+            fds.push_back(pollfd { connection.fd, events, 0 });
+        }
+
+        if (poll(fds.data(), fds.size(), timeout) < 0) {
+            if (errno == EINTR)
+                continue;
+
+            cerr << "poll: " << strerror(errno) << endl;
+            break;
+        }
+
+        for (size_t i = 0; i < connections.size(); ++i)
+            if (connections[i].wants_input() && (fds[i + 1].revents & (POLLIN | POLLHUP | POLLERR)))
+                read_requests(connections[i], i, batch);
+
+        for (auto& entry : batch)
+            request_count += entry.second.size();
+
+        evaluation_count += batch.size();
+        evaluate_batch(batch, context, connections);
+        batch.clear();
+
+        for (connection_t& connection : connections)
+            if (!connection.closed && !connection.output.empty())
+                write_responses(connection);
+
+        size_t kept = 0;
+
+        for (size_t i = 0; i < connections.size(); ++i) {
+            if (connections[i].closed || (connections[i].eof && connections[i].output.empty()))
+                close(connections[i].fd);
+            else if (kept++ != i)
+                connections[kept - 1] = std::move(connections[i]);
+        }
+
+        connections.resize(kept);
+
+        if (fds[0].revents & POLLIN)
+            while (true) {
+                int fd = accept(listener, NULL, NULL);
+
+                if (fd >= 0) {
+                    set_non_blocking(fd);
+                    connections.push_back(connection_t { fd, "", "", false, false });
+                    continue;
+                }
+
+                if (errno == EINTR || errno == ECONNABORTED)
+                    continue;
+
+                if (errno == EMFILE || errno == ENFILE || errno == ENOBUFS || errno == ENOMEM) {
+                    cerr << "accept: " << strerror(errno) << ", pausing for " << ACCEPT_BACKOFF_MS << " ms" << endl;
+                    accepting_paused = true;
+                    accept_resume_at = steady_clock_t::now() + chrono::milliseconds(ACCEPT_BACKOFF_MS);
+                }
+                else if (errno != EAGAIN && errno != EWOULDBLOCK)
+                    cerr << "accept: " << strerror(errno) << endl;
+
+                break;
+            }
+    }
+
+    for (connection_t& connection : connections)
+        close(connection.fd);
+
+    close(listener);
+    unlink(path.c_str());
+
+    cerr << "served " << request_count << " requests with " << evaluation_count << " evaluations" << endl;
+    return 0;
+}
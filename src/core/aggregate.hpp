@@ -0,0 +1,306 @@
+/*
+ * author: Luis Enrique Arias Curbelo
+ * repo:   https://github.com/larias95/shunting_yard
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstddef>
+#include <exception>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+using namespace std;
+
+#include "context.hpp"
+#include "lexer.hpp"
+#include "parser.hpp"
+
+namespace sy {
+
+/*
+ * Streaming reducers. Every reducer supports:
+ *   push(value)  - folds one result in,
+ *   merge(other) - folds in another reducer of the same kind,
+ *   clear()      - resets it to its empty state (keeping its configuration).
+ *
+ * sum_t, min_t, max_t and mean_t expose their result through value(). The sum
+ * of no results is 0; min, max and mean of no results are undefined, so their
+ * value() throws while `count` is 0. Sums and means of integral types throw
+ * rather than overflow.
+ */
+
+/*
+ * Running total behind sum_t and mean_t. Floating point values are summed with
+ * Neumaier's compensated summation, floats in a double; integral values are
+ * summed exactly and throw on overflow.
+ */
+template <typename T, bool integral = is_integral<T>::value>
+struct _accumulator_t;
+
+template <typename T>
+struct _accumulator_t<T, false> {
+    typedef typename conditional<is_same<T, float>::value, double, T>::type wide_t;
+
+    wide_t sum = 0;
+    wide_t compensation = 0;
+
+    void add(wide_t x) {
+        wide_t total = sum + x;
+
+        if (std::abs(sum) >= std::abs(x))
+            compensation += (sum - total) + x;
+        else
+            compensation += (x - total) + sum;
+
+        sum = total;
+    }
+
+    void merge(const _accumulator_t& other) {
+        add(other.sum);
+        compensation += other.compensation;
+    }
+
+    void clear() { sum = compensation = 0; }
+
+    wide_t total() const { return sum + compensation; }
+};
+
+template <typename T>
+struct _accumulator_t<T, true> {
+    T sum = 0;
+
+    void add(T x) {
+        if (__builtin_add_overflow(sum, x, &sum))
+            throw runtime_error("Integer overflow.");
+    }
+
+    void merge(const _accumulator_t& other) { add(other.sum); }
+
+    void clear() { sum = 0; }
+
+    T total() const { return sum; }
+};
+
+template <typename T>
+struct sum_t {
+    _accumulator_t<T> accumulator;
+    size_t count = 0;
+
+    void push(T x) { accumulator.add(x); ++count; }
+    void merge(const sum_t& other) { accumulator.merge(other.accumulator); count += other.count; }
+    void clear() { accumulator.clear(); count = 0; }
+
+    T value() const {
+        return static_cast<T>(accumulator.total());
+    }
+};
+
+template <typename T>
+struct min_t {
+    T minimum = numeric_limits<T>::max();
+    size_t count = 0;
+
+    void push(T x) { minimum = std::min(minimum, x); ++count; }
+    void merge(const min_t& other) { minimum = std::min(minimum, other.minimum); count += other.count; }
+    void clear() { minimum = numeric_limits<T>::max(); count = 0; }
+
+    T value() const {
+        if (count == 0)
+            throw runtime_error("Minimum of an empty sequence.");
+
+        return minimum;
+    }
+};
+
+template <typename T>
+struct max_t {
+    T maximum = numeric_limits<T>::lowest();
+    size_t count = 0;
+
+    void push(T x) { maximum = std::max(maximum, x); ++count; }
+    void merge(const max_t& other) { maximum = std::max(maximum, other.maximum); count += other.count; }
+    void clear() { maximum = numeric_limits<T>::lowest(); count = 0; }
+
+    T value() const {
+        if (count == 0)
+            throw runtime_error("Maximum of an empty sequence.");
+
+        return maximum;
+    }
+};
+
+template <typename T>
+struct mean_t {
+    _accumulator_t<T> accumulator;
+    size_t count = 0;
+
+    void push(T x) { accumulator.add(x); ++count; }
+    void merge(const mean_t& other) { accumulator.merge(other.accumulator); count += other.count; }
+    void clear() { accumulator.clear(); count = 0; }
+
+    T value() const {
+        if (count == 0)
+            throw runtime_error("Mean of an empty sequence.");
+
+        auto total = accumulator.total();
+        return static_cast<T>(total / static_cast<decltype(total)>(count));
+    }
+};
+
+template <typename T>
+struct histogram_t {
+    T lower;
+    T upper;
+    vector<size_t> bins;
+    size_t underflow = 0;
+    size_t overflow = 0;
+
+    // `count` equally wide bins over [lower, upper).
+    histogram_t(T lower, T upper, size_t count):
+    lower(lower),
+    upper(upper),
+    bins(count, 0) {
+        if (count == 0 || !(lower < upper))
+            throw runtime_error("Invalid histogram range.");
+    }
+
+    void push(T x) {
+        if (x < lower)
+            ++underflow;
+        else if (!(x < upper))
+            ++overflow;
+        else {
+            size_t bin = static_cast<size_t>((x - lower) * static_cast<T>(bins.size()) / (upper - lower));
+            ++bins[std::min(bin, bins.size() - 1)];
+        }
+    }
+
+    void merge(const histogram_t& other) {
+        assert(bins.size() == other.bins.size());
+
+        for (size_t i = 0; i < bins.size(); ++i)
+            bins[i] += other.bins[i];
+
+        underflow += other.underflow;
+        overflow += other.overflow;
+    }
+
+    void clear() {
+        std::fill(bins.begin(), bins.end(), 0);
+        underflow = overflow = 0;
+    }
+};
+
+/*
+ * Evaluates an RPN sequence folding its results into `reducer`
+ * instead of collecting them.
+ */
+template <typename T, typename R>
+inline void rpn_reduce(
+    const vector<token_t>& rpn,
+    const ParsingContext<T>* context,
+    R& reducer
+) {
+    auto sink = [&reducer](T value) { reducer.push(value); };
+    rpn_fold(rpn, context, sink);
+}
+
+template <typename T, typename R>
+inline void _batch_reduce_range(
+    const vector<token_t>& rpn,
+    ParsingContext<T>& context,
+    const vector<string>& names,
+    const T* data,
+    size_t first,
+    size_t last,
+    size_t stride,
+    R& reducer
+) {
+    vector<T*> slots;
+
+    for (const string& name : names)
+        slots.push_back(context.bind(name));
+
+    for (size_t i = first; i != last; ++i) {
+        const T* row = data + i * stride;
+
+        for (size_t j = 0; j < slots.size(); ++j)
+            *slots[j] = row[j];
+
+        rpn_reduce(rpn, &context, reducer);
+    }
+}
+
+/*
+ * Evaluates an RPN sequence once per row of a row-major buffer, binding `names`
+ * to the first values of the row, and folds every result into `reducer`.
+ * Row i starts at data[i * stride]. Names are resolved once, not per row, and
+ * must not be readonly in `context`. With several threads each one works on a
+ * copy of the context and its own reducer, and they are merged at the end.
+ */
+template <typename T, typename R>
+inline void batch_reduce(
+    const vector<token_t>& rpn,
+    const ParsingContext<T>* context,
+    const vector<string>& names,
+    const T* data,
+    size_t rows,
+    size_t stride,
+    R& reducer,
+    size_t threads=1
+) {
+    ENSURE_TOKENS_SEQUENCE(rpn);
+
+    if (stride < names.size())
+        throw runtime_error("Row stride " + to_string(stride) + " is shorter than the " + to_string(names.size()) + " bound names.");
+
+    threads = std::max<size_t>(1, std::min(threads, rows));
+
+    if (threads == 1) {
+        ParsingContext<T> local(*context);
+        _batch_reduce_range(rpn, local, names, data, 0, rows, stride, reducer);
+        return;
+    }
+
+    R empty(reducer);
+    empty.clear();
+
+    vector<R> partials(threads, empty);
+    vector<exception_ptr> errors(threads);
+    vector<thread> workers;
+
+    size_t chunk = (rows + threads - 1) / threads;
+
+    for (size_t t = 0; t < threads; ++t)
+        workers.push_back(thread([&, t]() {
+            try {
+                ParsingContext<T> local(*context);
+                size_t first = std::min(rows, t * chunk);
+                size_t last = std::min(rows, first + chunk);
+                _batch_reduce_range(rpn, local, names, data, first, last, stride, partials[t]);
+            }
+            catch (...) {
+                errors[t] = current_exception();
+            }
+        }));
+
+    for (thread& worker : workers)
+        worker.join();
+
+    for (exception_ptr& error : errors)
+        if (error)
+            rethrow_exception(error);
+
+    for (R& partial : partials)
+        reducer.merge(partial);
+}
+
+}
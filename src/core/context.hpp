@@ -6,6 +6,7 @@
 #pragma once
 
 #include <cassert>
+#include <memory>
 #include <stdexcept>
 #include <string>
 #include <unordered_map>
@@ -13,16 +14,19 @@
 
 using namespace std;
 
+#include "lexer.hpp"
+
 namespace sy {
 
+template <typename T>
 class Evaluable_t {
 public:
-    typedef double (*handler_t)(const vector<double>& args);
+    typedef T (*handler_t)(const vector<T>& args);
 
     int const arity;
     handler_t const handler;
 
-    double evaluate(const vector<double>& args) const {
+    T evaluate(const vector<T>& args) const {
         assert(args.size() == arity);
         return handler(args);
     }
@@ -39,8 +43,11 @@ protected:
     }
 };
 
-class Operator_t : public Evaluable_t {
+template <typename T>
+class Operator_t : public Evaluable_t<T> {
 public:
+    typedef typename Evaluable_t<T>::handler_t handler_t;
+
     enum assoc_t {
         LEFT,
         RIGHT,
@@ -64,72 +71,133 @@ public:
 
 private:
     Operator_t(int arity, int precedence, assoc_t associativity, handler_t handler):
-    Evaluable_t(arity, handler),
+    Evaluable_t<T>(arity, handler),
     precedence(precedence),
     associativity(associativity) {
 
     }
 };
 
+class Definition_t {
+public:
+    int const arity;
+    vector<string> const params;
+    vector<token_t> const body; // RPN sequence without its END token
+
+    static Definition_t* Inline(const vector<string>& params, const vector<token_t>& body) {
+        return new Definition_t(params, body);
+    }
+
+private:
+    Definition_t(const vector<string>& params, const vector<token_t>& body):
+    arity(params.size()),
+    params(params),
+    body(body) {
+
+    }
+};
+
+template <typename T>
 struct entity_t {
     enum content_t {
         NONE,
         VALUE,
         FUNCTION,
         OPERATOR,
+        DEFINITION,
     };
 
     content_t content;
     bool is_readonly;
 
     union {
-        double value;
-        Evaluable_t* function;
-        Operator_t* operator_;
+        T value;
+        Evaluable_t<T>* function;
+        Operator_t<T>* operator_;
+        Definition_t* definition;
     };
-} const NO_ENTITY {
-    entity_t::content_t::NONE,
 };
 
+template <typename T>
+const entity_t<T> NO_ENTITY {
+    entity_t<T>::content_t::NONE,
+};
+
+template <typename T>
 class ParsingContext {
 public:
-    ParsingContext* set(const string& key, double value, bool as_readonly=true) {
+    ParsingContext* set(const string& key, T value, bool as_readonly=true) {
         check_key_is_assignable(key);
 
-        entity_t entity;
-        entity.content = entity_t::content_t::VALUE;
+        entity_t<T> entity;
+        entity.content = entity_t<T>::content_t::VALUE;
         entity.is_readonly = as_readonly;
         entity.value = value;
-        entities[key] = entity;
+        store(key, entity);
 
         return this;
     }
 
-    ParsingContext* set(const string& key, Evaluable_t* function, bool as_readonly=true) {
+    ParsingContext* set(const string& key, Evaluable_t<T>* function, bool as_readonly=true) {
         check_key_is_assignable(key);
 
-        entity_t entity;
-        entity.content = entity_t::content_t::FUNCTION;
+        entity_t<T> entity;
+        entity.content = entity_t<T>::content_t::FUNCTION;
         entity.is_readonly = as_readonly;
         entity.function = function;
-        entities[key] = entity;
+        store(key, entity);
         
         return this;
     }
 
-    ParsingContext* set(const string& key, Operator_t* operator_, bool as_readonly=true) {
+    ParsingContext* set(const string& key, Operator_t<T>* operator_, bool as_readonly=true) {
         check_key_is_assignable(key);
 
-        entity_t entity;
-        entity.content = entity_t::content_t::OPERATOR;
+        entity_t<T> entity;
+        entity.content = entity_t<T>::content_t::OPERATOR;
         entity.is_readonly = as_readonly;
         entity.operator_ = operator_;
-        entities[key] = entity;
+        store(key, entity);
         
         return this;
     }
 
-    entity_t get(const string& key) const {
+    /*
+     * Unlike functions and operators, definitions are owned by the context (and
+     * shared with its copies), so replacing one frees it once no copy uses it.
+     */
+    ParsingContext* set(const string& key, const shared_ptr<Definition_t>& definition, bool as_readonly=true) {
+        check_key_is_assignable(key);
+
+        entity_t<T> entity;
+        entity.content = entity_t<T>::content_t::DEFINITION;
+        entity.is_readonly = as_readonly;
+        entity.definition = definition.get();
+        store(key, entity);
+        definitions[key] = definition;
+        
+        return this;
+    }
+
+    /*
+     * Makes `key` a writable value (keeping its current value if it already is
+     * one) and returns where that value lives, so it can be rebound without
+     * looking `key` up again. The pointer stays valid until `key` is set again.
+     */
+    T* bind(const string& key) {
+        auto result = entities.find(key);
+
+        if (result == entities.end() || result->second.content != entity_t<T>::content_t::VALUE) {
+            set(key, T(), false);
+            result = entities.find(key);
+        }
+        else if (result->second.is_readonly)
+            throw runtime_error("Entity " + key + " is readonly.");
+
+        return &result->second.value;
+    }
+
+    entity_t<T> get(const string& key) const {
         auto result = entities.find(key);
 
         if (result == entities.end())
@@ -139,7 +207,13 @@ public:
     }
 
 private:
-    unordered_map<string, entity_t> entities;
+    unordered_map<string, entity_t<T>> entities;
+    unordered_map<string, shared_ptr<Definition_t>> definitions;
+
+    void store(const string& key, const entity_t<T>& entity) {
+        entities[key] = entity;
+        definitions.erase(key);
+    }
 
     void check_key_is_assignable(const string& key) const {
         auto result = entities.find(key);
@@ -25,6 +25,7 @@ struct token_t {
         LPARENT,      // (
         RPARENT,      // )
         COMMA,        // ,
+        ASSIGN,       // =
         END,          // end of a sequence of tokens
         UNKNOWN = -1, // otherwise
     };
@@ -51,6 +52,7 @@ inline const char* name(token_t::kind_t token_kind) {
         case token_t::kind_t::LPARENT: return "LPARENT";
         case token_t::kind_t::RPARENT: return "RPARENT";
         case token_t::kind_t::COMMA: return "COMMA";
+        case token_t::kind_t::ASSIGN: return "ASSIGN";
         case token_t::kind_t::END: return "END";
         case token_t::kind_t::UNKNOWN: return "UNKNOWN";
     }
@@ -71,6 +73,7 @@ inline void tokenize(const string& line, vector<token_t>& tokens) {
         make_pair(token_t::kind_t::LPARENT, regex("^\\(")),
         make_pair(token_t::kind_t::RPARENT, regex("^\\)")),
         make_pair(token_t::kind_t::COMMA, regex("^,")),
+        make_pair(token_t::kind_t::ASSIGN, regex("^=")),
     };
 
     auto head = line.begin();
@@ -86,7 +89,9 @@ inline void tokenize(const string& line, vector<token_t>& tokens) {
             for (auto& pattern : patterns) {
                 smatch prefix;
 
-                if (regex_search(head, line.end(), prefix, pattern.second) && prefix[0].length() > longest_prefix.length()) {
+                // match_continuous anchors the match at head, so the rest of the line is not rescanned
+                if (regex_search(head, line.end(), prefix, pattern.second, regex_constants::match_continuous) &&
+                    prefix[0].length() > longest_prefix.length()) {
                     token_kind = pattern.first;
                     longest_prefix = prefix[0].str();
                 }
@@ -0,0 +1,65 @@
+/*
+ * author: Luis Enrique Arias Curbelo
+ * repo:   https://github.com/larias95/shunting_yard
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+namespace sy {
+
+/*
+ * Numeric traits for the types the pipeline can be instantiated with.
+ * Each specialization knows how to turn a NUMBER token into a value.
+ */
+template <typename T>
+struct numeric_traits;
+
+template <>
+struct numeric_traits<float> {
+    static const char* name() { return "float"; }
+
+    static float parse(const string& text) {
+        return std::stof(text);
+    }
+};
+
+template <>
+struct numeric_traits<double> {
+    static const char* name() { return "double"; }
+
+    static double parse(const string& text) {
+        return std::stod(text);
+    }
+};
+
+template <>
+struct numeric_traits<long double> {
+    static const char* name() { return "long double"; }
+
+    static long double parse(const string& text) {
+        return std::stold(text);
+    }
+};
+
+template <>
+struct numeric_traits<int64_t> {
+    static const char* name() { return "int64"; }
+
+    static int64_t parse(const string& text) {
+        size_t length;
+        int64_t value = std::stoll(text, &length);
+
+        if (length != text.length())
+            throw runtime_error("Invalid integer literal " + text + ".");
+
+        return value;
+    }
+};
+
+}
@@ -7,8 +7,10 @@
 
 #include <algorithm>
 #include <cassert>
+#include <memory>
 #include <stack>
 #include <stdexcept>
+#include <string>
 #include <utility>
 #include <vector>
 
@@ -16,6 +18,7 @@ using namespace std;
 
 #include "lexer.hpp"
 #include "context.hpp"
+#include "numeric.hpp"
 
 namespace sy {
 
@@ -25,9 +28,10 @@ namespace sy {
 #define THROW_INVALID_TOKEN(tok) \
     throw runtime_error("Invalid token " + (tok).str() + ".");
 
+template <typename T>
 inline void _check_type_0 /* eps, comma, binary operator, prefix unary operator */ (
     const token_t& token,
-    const ParsingContext* context
+    const ParsingContext<T>* context
 ) {
     if (token.kind == token_t::kind_t::NUMBER ||
         token.kind == token_t::kind_t::IDENTIFIER ||
@@ -35,18 +39,19 @@ inline void _check_type_0 /* eps, comma, binary operator, prefix unary operator
         return;
     
     if (token.kind == token_t::kind_t::OPERATOR) {
-        Operator_t* op = context->get(token.text).operator_;
+        Operator_t<T>* op = context->get(token.text).operator_;
 
-        if (op->arity == 1 && op->associativity == Operator_t::assoc_t::RIGHT)
+        if (op->arity == 1 && op->associativity == Operator_t<T>::assoc_t::RIGHT)
             return;
     }
 
     THROW_INVALID_TOKEN(token);
 }
 
+template <typename T>
 inline void _check_type_1 /* number, value, right parent., postfix unary operator */ (
     const token_t& token,
-    const ParsingContext* context
+    const ParsingContext<T>* context
 ) {
     if (token.kind == token_t::kind_t::RPARENT ||
         token.kind == token_t::kind_t::COMMA ||
@@ -54,21 +59,22 @@ inline void _check_type_1 /* number, value, right parent., postfix unary operato
         return;
     
     if (token.kind == token_t::kind_t::OPERATOR) {
-        Operator_t* op = context->get(token.text).operator_;
+        Operator_t<T>* op = context->get(token.text).operator_;
 
         if (op->arity == 2)
             return;
         
-        if (op->arity == 1 && op->associativity == Operator_t::assoc_t::LEFT)
+        if (op->arity == 1 && op->associativity == Operator_t<T>::assoc_t::LEFT)
             return;
     }
 
     THROW_INVALID_TOKEN(token);
 }
 
+template <typename T>
 inline void _check_type_2 /* function */ (
     const token_t& token,
-    const ParsingContext* context
+    const ParsingContext<T>* context
 ) {
     if (token.kind == token_t::kind_t::LPARENT)
         return;
@@ -76,9 +82,10 @@ inline void _check_type_2 /* function */ (
     THROW_INVALID_TOKEN(token);
 }
 
+template <typename T>
 inline void _check_type_3 /* left parent. */ (
     const token_t& token,
-    const ParsingContext* context
+    const ParsingContext<T>* context
 ) {
     if (token.kind == token_t::kind_t::NUMBER ||
         token.kind == token_t::kind_t::IDENTIFIER ||
@@ -87,18 +94,19 @@ inline void _check_type_3 /* left parent. */ (
         return;
     
     if (token.kind == token_t::kind_t::OPERATOR) {
-        Operator_t* op = context->get(token.text).operator_;
+        Operator_t<T>* op = context->get(token.text).operator_;
 
-        if (op->arity == 1 && op->associativity == Operator_t::assoc_t::RIGHT)
+        if (op->arity == 1 && op->associativity == Operator_t<T>::assoc_t::RIGHT)
             return;
     }
 
     THROW_INVALID_TOKEN(token);
 }
 
+template <typename T>
 inline void _check_relative_position(
     const vector<token_t>& tokens,
-    const ParsingContext* context
+    const ParsingContext<T>* context
 ) {
     auto head = tokens.begin();
     
@@ -116,9 +124,9 @@ inline void _check_relative_position(
                 break;
             
             case token_t::kind_t::OPERATOR: {
-                Operator_t* op = context->get(head->text).operator_;
+                Operator_t<T>* op = context->get(head->text).operator_;
 
-                if (op->arity == 1 && op->associativity == Operator_t::assoc_t::LEFT)
+                if (op->arity == 1 && op->associativity == Operator_t<T>::assoc_t::LEFT)
                     _check_type_1(*next, context);
                 else
                     _check_type_0(*next, context);
@@ -126,7 +134,7 @@ inline void _check_relative_position(
             }
             
             case token_t::kind_t::IDENTIFIER:
-                if (context->get(head->text).content == entity_t::content_t::VALUE)
+                if (context->get(head->text).content == entity_t<T>::content_t::VALUE)
                     _check_type_1(*next, context);
                 else
                     _check_type_2(*next, context);
@@ -147,29 +155,31 @@ inline void _check_relative_position(
     }
 }
 
-inline bool _should_pop(const entity_t& head, const entity_t& top) {
-    if (top.content == entity_t::content_t::NONE)
+template <typename T>
+inline bool _should_pop(const entity_t<T>& head, const entity_t<T>& top) {
+    if (top.content == entity_t<T>::content_t::NONE)
         return false;
     
     if (head.operator_->precedence > top.operator_->precedence)
         return false;
     
     if (head.operator_->precedence == top.operator_->precedence)
-        return head.operator_->associativity == Operator_t::assoc_t::LEFT;
+        return head.operator_->associativity == Operator_t<T>::assoc_t::LEFT;
     
     return true;
 }
 
-inline void to_rpn(
+template <typename T>
+inline void _shunting_yard(
     const vector<token_t>& tokens,
-    const ParsingContext* context,
+    const ParsingContext<T>* context,
     vector<token_t>& rpn
 ) {
     ENSURE_TOKENS_SEQUENCE(tokens);
 
     _check_relative_position(tokens, context);
 
-    stack<pair<token_t, entity_t>> op_stack;
+    stack<pair<token_t, entity_t<T>>> op_stack;
 
     for (const token_t& token : tokens)
         switch (token.kind) {
@@ -178,7 +188,7 @@ inline void to_rpn(
                 break;
             
             case token_t::kind_t::OPERATOR: {
-                entity_t entity = context->get(token.text);
+                entity_t<T> entity = context->get(token.text);
 
                 while (!op_stack.empty() && _should_pop(entity, op_stack.top().second)) {
                     rpn.push_back(op_stack.top().first);
@@ -191,19 +201,19 @@ inline void to_rpn(
             }
 
             case token_t::kind_t::IDENTIFIER: {
-                entity_t entity = context->get(token.text);
+                entity_t<T> entity = context->get(token.text);
 
-                if (entity.content == entity_t::content_t::VALUE)
+                if (entity.content == entity_t<T>::content_t::VALUE)
                     rpn.push_back(token);
                 
-                else // entity_t::content_t::FUNCTION
+                else // entity_t<T>::content_t::FUNCTION, entity_t<T>::content_t::DEFINITION
                     op_stack.push(make_pair(token, entity));
 
                 break;
             }
             
             case token_t::kind_t::LPARENT:
-                op_stack.push(make_pair(token, NO_ENTITY));
+                op_stack.push(make_pair(token, NO_ENTITY<T>));
                 break;
             
             case token_t::kind_t::RPARENT:
@@ -244,39 +254,247 @@ inline void to_rpn(
         }
 }
 
-inline void rpn_eval(
+/*
+ * Maximum nesting of user definitions expanded into a single call site.
+ * It bounds (otherwise endless) recursive definitions.
+ */
+const int MAX_INLINE_DEPTH = 64;
+
+/*
+ * Maximum number of tokens inlining may add to an RPN sequence, which bounds
+ * definitions that use their parameters many times over several levels.
+ * Sequences are checked against `limit` (their input length plus this) as they
+ * grow, so it bounds the work done as well, while leaving plain expressions alone.
+ */
+const size_t MAX_INLINE_LENGTH = 1 << 16;
+
+inline void _check_inline_length(size_t length, size_t limit, const token_t& token) {
+    if (length > limit)
+        throw runtime_error("Inlining " + token.str() + " grows the expression by more than " + to_string(MAX_INLINE_LENGTH) + " tokens.");
+}
+
+inline void _push_inlined(vector<token_t>& out, size_t limit, const token_t& token) {
+    _check_inline_length(out.size() + 1, limit, token);
+    out.push_back(token);
+}
+
+/*
+ * Copies `rpn` into `out`, replacing every call to a user definition with its
+ * body, where each parameter is in turn replaced by the RPN of its argument.
+ * The start of every value computed so far is tracked so that arguments can be
+ * cut out of `out`. Returns the number of values left after the last END token.
+ */
+template <typename T>
+inline size_t _inline_definitions(
+    const vector<token_t>& rpn,
+    const ParsingContext<T>* context,
+    vector<token_t>& out,
+    size_t limit,
+    int depth
+) {
+    vector<size_t> starts;
+
+    for (const token_t& token : rpn)
+        switch (token.kind) {
+            case token_t::kind_t::NUMBER:
+                starts.push_back(out.size());
+                _push_inlined(out, limit, token);
+                break;
+
+            case token_t::kind_t::OPERATOR:
+            case token_t::kind_t::IDENTIFIER: {
+                entity_t<T> entity = context->get(token.text);
+
+                size_t arity = 0;
+
+                switch (entity.content) {
+                    case entity_t<T>::content_t::FUNCTION: arity = entity.function->arity; break;
+                    case entity_t<T>::content_t::OPERATOR: arity = entity.operator_->arity; break;
+                    case entity_t<T>::content_t::DEFINITION: arity = entity.definition->arity; break;
+                    default: break;
+                }
+
+                if (starts.size() < arity)
+                    throw runtime_error("Too few arguments for " + token.str() + ".");
+
+                size_t start = (arity > 0) ? starts[starts.size() - arity] : out.size();
+
+                if (entity.content != entity_t<T>::content_t::DEFINITION)
+                    _push_inlined(out, limit, token);
+
+                else {
+                    if (depth == MAX_INLINE_DEPTH)
+                        throw runtime_error("Inlining " + token.str() + " exceeds the maximum depth of " + to_string(MAX_INLINE_DEPTH) + ".");
+
+                    const Definition_t* definition = entity.definition;
+                    vector<vector<token_t>> args;
+
+                    for (size_t i = 0; i < arity; ++i) {
+                        auto first = out.begin() + starts[starts.size() - arity + i];
+                        auto last = (i + 1 < arity) ? out.begin() + starts[starts.size() - arity + i + 1] : out.end();
+                        args.push_back(vector<token_t>(first, last));
+                    }
+
+                    out.erase(out.begin() + start, out.end());
+
+                    vector<token_t> body;
+
+                    for (const token_t& body_token : definition->body) {
+                        auto param = (body_token.kind == token_t::kind_t::IDENTIFIER)
+                                   ? std::find(definition->params.begin(), definition->params.end(), body_token.text)
+                                   : definition->params.end();
+
+                        if (param == definition->params.end())
+                            _push_inlined(body, limit, body_token);
+                        else {
+                            const vector<token_t>& arg = args[param - definition->params.begin()];
+                            _check_inline_length(body.size() + arg.size(), limit, token);
+                            body.insert(body.end(), arg.begin(), arg.end());
+                        }
+                    }
+
+                    _check_inline_length(out.size() + body.size(), limit, token);
+
+                    if (_inline_definitions(body, context, out, limit, depth + 1) != 1)
+                        throw runtime_error("Definition " + token.text + " does not reduce to a single value.");
+                }
+
+                starts.resize(starts.size() - arity);
+                starts.push_back(start);
+                break;
+            }
+
+            case token_t::kind_t::END:
+                _push_inlined(out, limit, token);
+                starts.clear();
+                break;
+
+            default:
+                THROW_INVALID_TOKEN(token);
+        }
+
+    return starts.size();
+}
+
+template <typename T>
+inline void to_rpn(
+    const vector<token_t>& tokens,
+    const ParsingContext<T>* context,
+    vector<token_t>& rpn
+) {
+    vector<token_t> raw;
+    _shunting_yard(tokens, context, raw);
+    _inline_definitions(raw, context, rpn, raw.size() + MAX_INLINE_LENGTH, 0);
+}
+
+inline bool is_definition(const vector<token_t>& tokens) {
+    return std::any_of(tokens.begin(), tokens.end(), [](const token_t& token) {
+        return token.kind == token_t::kind_t::ASSIGN;
+    });
+}
+
+/*
+ * Parses a definition such as `hypot(a, b) = sqrt(a^2 + b^2)` and stores it in
+ * the context, as a writable entity, under the function name, which is returned.
+ * The body is kept as RPN and inlined by to_rpn wherever the function is called.
+ */
+template <typename T>
+inline string define(
+    const vector<token_t>& tokens,
+    ParsingContext<T>* context
+) {
+    ENSURE_TOKENS_SEQUENCE(tokens);
+
+    auto head = tokens.begin();
+
+    if (head->kind != token_t::kind_t::IDENTIFIER)
+        THROW_INVALID_TOKEN(*head);
+
+    string name = (head++)->text;
+
+    if (head->kind != token_t::kind_t::LPARENT)
+        THROW_INVALID_TOKEN(*head);
+
+    vector<string> params;
+
+    for (++head; head->kind != token_t::kind_t::RPARENT; ++head) {
+        if (!params.empty()) {
+            if (head->kind != token_t::kind_t::COMMA)
+                THROW_INVALID_TOKEN(*head);
+            ++head;
+        }
+
+        if (head->kind != token_t::kind_t::IDENTIFIER)
+            THROW_INVALID_TOKEN(*head);
+
+        if (head->text == name || std::find(params.begin(), params.end(), head->text) != params.end())
+            throw runtime_error("Invalid parameter " + head->str() + ".");
+
+        params.push_back(head->text);
+    }
+
+    if ((++head)->kind != token_t::kind_t::ASSIGN)
+        THROW_INVALID_TOKEN(*head);
+
+    // the body is parsed with the parameters bound as values, and the function
+    // itself already declared, so that it may refer to itself
+    ParsingContext<T> local(*context);
+    local.set(name, shared_ptr<Definition_t>(Definition_t::Inline(params, vector<token_t>())), false);
+
+    for (const string& param : params)
+        local.set(param, T(), false);
+
+    vector<token_t> body;
+    _shunting_yard(vector<token_t>(head + 1, tokens.end()), &local, body);
+    body.pop_back();
+
+    shared_ptr<Definition_t> definition(Definition_t::Inline(params, body));
+    local.set(name, definition, false);
+
+    vector<token_t> inlined;
+
+    if (_inline_definitions(body, &local, inlined, body.size() + MAX_INLINE_LENGTH, 0) != 1)
+        throw runtime_error("Definition " + name + " does not reduce to a single value.");
+
+    context->set(name, definition, false);
+
+    return name;
+}
+
+template <typename T, typename Sink>
+inline void rpn_fold(
     const vector<token_t>& rpn,
-    const ParsingContext* context,
-    vector<double>& results
+    const ParsingContext<T>* context,
+    Sink& sink
 ) {
     ENSURE_TOKENS_SEQUENCE(rpn);
 
-    stack<double> args_stack;
+    stack<T> args_stack;
 
     for (const token_t& token : rpn)
         switch (token.kind) {
             case token_t::kind_t::NUMBER:
-                args_stack.push(std::stod(token.text));
+                args_stack.push(numeric_traits<T>::parse(token.text));
                 break;
             
             case token_t::kind_t::OPERATOR:
             case token_t::kind_t::IDENTIFIER: {
-                entity_t entity = context->get(token.text);
+                entity_t<T> entity = context->get(token.text);
 
                 switch (entity.content) {
-                    case entity_t::content_t::VALUE:
+                    case entity_t<T>::content_t::VALUE:
                         args_stack.push(entity.value);
                         break;
                     
-                    case entity_t::content_t::FUNCTION:
-                    case entity_t::content_t::OPERATOR: {
-                        Evaluable_t* op = (entity.content == entity_t::content_t::FUNCTION)
+                    case entity_t<T>::content_t::FUNCTION:
+                    case entity_t<T>::content_t::OPERATOR: {
+                        Evaluable_t<T>* op = (entity.content == entity_t<T>::content_t::FUNCTION)
                                         ? entity.function : entity.operator_;
                         
                         if (args_stack.size() < op->arity)
                             throw runtime_error("Too few arguments for " + token.str() + ".");
 
-                        vector<double> args;
+                        vector<T> args;
 
                         while (args.size() != op->arity) {
                             args.push_back(args_stack.top());
@@ -287,6 +505,9 @@ inline void rpn_eval(
                         args_stack.push(op->evaluate(args));
                         break;
                     }
+
+                    case entity_t<T>::content_t::DEFINITION:
+                        throw runtime_error("Definition " + token.str() + " was not inlined.");
                 }
                 break;
             }
@@ -295,7 +516,7 @@ inline void rpn_eval(
                 if (args_stack.size() != 1)
                     throw runtime_error("RPN sequence could not be reduced to a single value.");
                 
-                results.push_back(args_stack.top());
+                sink(args_stack.top());
                 args_stack.pop();
                 break;
             
@@ -304,4 +525,14 @@ inline void rpn_eval(
         }
 }
 
+template <typename T>
+inline void rpn_eval(
+    const vector<token_t>& rpn,
+    const ParsingContext<T>* context,
+    vector<T>& results
+) {
+    auto sink = [&results](T value) { results.push_back(value); };
+    rpn_fold(rpn, context, sink);
+}
+
 }
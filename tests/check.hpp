@@ -0,0 +1,43 @@
+/*
+ * author: Luis Enrique Arias Curbelo
+ * repo:   https://github.com/larias95/shunting_yard
+ */
+
+#pragma once
+
+#include <exception>
+#include <iostream>
+
+using namespace std;
+
+/*
+ * Minimal checks for the test executables: failures are reported and counted,
+ * and check_report() turns the count into the process exit status.
+ */
+
+inline int& check_failures() {
+    static int failures = 0;
+    return failures;
+}
+
+#define CHECK(cond) \
+    if (!(cond)) { \
+        cerr << __FILE__ << ":" << __LINE__ << ": CHECK(" #cond ") failed" << endl; \
+        ++check_failures(); \
+    }
+
+#define CHECK_THROWS(expr) \
+    try { \
+        expr; \
+        cerr << __FILE__ << ":" << __LINE__ << ": CHECK_THROWS(" #expr ") did not throw" << endl; \
+        ++check_failures(); \
+    } \
+    catch (exception&) { \
+    }
+
+inline int check_report() {
+    if (check_failures() != 0)
+        cerr << check_failures() << " check(s) failed" << endl;
+
+    return check_failures() == 0 ? 0 : 1;
+}
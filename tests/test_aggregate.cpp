@@ -0,0 +1,224 @@
+/*
+ * author: Luis Enrique Arias Curbelo
+ * repo:   https://github.com/larias95/shunting_yard
+ */
+
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+#include "aggregate.hpp"
+#include "check.hpp"
+#include "lexer.hpp"
+#include "my_context.hpp"
+#include "parser.hpp"
+
+using namespace sy;
+
+template <typename T>
+vector<token_t> compile(const string& line, const ParsingContext<T>* context) {
+    vector<token_t> tokens;
+    vector<token_t> rpn;
+
+    tokenize(line, tokens);
+    to_rpn(tokens, context, rpn);
+
+    return rpn;
+}
+
+/*
+ * Row-major rows of STRIDE values: x in 0..n-1, y = 1 and an unused column,
+ * so `x * 2 + y` takes every odd value in 1..2n-1.
+ */
+const size_t STRIDE = 3;
+
+template <typename T>
+vector<T> make_rows(size_t n) {
+    vector<T> rows;
+
+    for (size_t i = 0; i < n; ++i)
+        rows.insert(rows.end(), { T(i), T(1), T(-1) });
+
+    return rows;
+}
+
+template <typename T>
+void test_threads_agree() {
+    ParsingContext<T>* context = get_context<T>();
+    context->set("x", T(0), false)->set("y", T(0), false);
+
+    vector<token_t> rpn = compile<T>("x * 2 + y", context);
+    vector<string> names { "x", "y" };
+    vector<T> rows = make_rows<T>(1000);
+
+    for (size_t threads : { 2, 3, 8 }) {
+        sum_t<T> sum_1, sum_n;
+        min_t<T> min_1, min_n;
+        max_t<T> max_1, max_n;
+        mean_t<T> mean_1, mean_n;
+        histogram_t<T> histogram_1(0, 1000, 10), histogram_n(0, 1000, 10);
+
+        batch_reduce(rpn, context, names, rows.data(), 1000, STRIDE, sum_1);
+        batch_reduce(rpn, context, names, rows.data(), 1000, STRIDE, sum_n, threads);
+        batch_reduce(rpn, context, names, rows.data(), 1000, STRIDE, min_1);
+        batch_reduce(rpn, context, names, rows.data(), 1000, STRIDE, min_n, threads);
+        batch_reduce(rpn, context, names, rows.data(), 1000, STRIDE, max_1);
+        batch_reduce(rpn, context, names, rows.data(), 1000, STRIDE, max_n, threads);
+        batch_reduce(rpn, context, names, rows.data(), 1000, STRIDE, mean_1);
+        batch_reduce(rpn, context, names, rows.data(), 1000, STRIDE, mean_n, threads);
+        batch_reduce(rpn, context, names, rows.data(), 1000, STRIDE, histogram_1);
+        batch_reduce(rpn, context, names, rows.data(), 1000, STRIDE, histogram_n, threads);
+
+        CHECK(sum_1.value() == T(1000000) && sum_n.value() == sum_1.value());
+        CHECK(sum_n.count == 1000);
+        CHECK(min_1.value() == T(1) && min_n.value() == min_1.value());
+        CHECK(max_1.value() == T(1999) && max_n.value() == max_1.value());
+        CHECK(mean_1.value() == T(1000) && mean_n.value() == mean_1.value());
+        CHECK(histogram_n.bins == histogram_1.bins);
+        CHECK(histogram_1.bins[0] == 50 && histogram_1.bins[9] == 50);
+        CHECK(histogram_1.overflow == 500 && histogram_n.overflow == 500);
+    }
+}
+
+template <typename T>
+void test_empty_rows() {
+    ParsingContext<T>* context = get_context<T>();
+    context->set("x", T(0), false);
+
+    vector<token_t> rpn = compile<T>("x + 1", context);
+    vector<T> rows;
+
+    for (size_t threads : { 1, 4 }) {
+        sum_t<T> sum;
+        min_t<T> min;
+        max_t<T> max;
+        mean_t<T> mean;
+
+        batch_reduce(rpn, context, { "x" }, rows.data(), 0, STRIDE, sum, threads);
+        batch_reduce(rpn, context, { "x" }, rows.data(), 0, STRIDE, min, threads);
+        batch_reduce(rpn, context, { "x" }, rows.data(), 0, STRIDE, max, threads);
+        batch_reduce(rpn, context, { "x" }, rows.data(), 0, STRIDE, mean, threads);
+
+        CHECK(sum.value() == 0 && sum.count == 0);
+        CHECK_THROWS(min.value());
+        CHECK_THROWS(max.value());
+        CHECK_THROWS(mean.value());
+    }
+}
+
+template <typename T>
+void test_bindings() {
+    ParsingContext<T>* context = get_context<T>();
+    context->set("x", T(0), false)->set("y", T(0), false);
+
+    vector<token_t> rpn = compile<T>("x + y", context);
+    vector<T> rows = make_rows<T>(100);
+
+    // rows shorter than the bound names
+    sum_t<T> sum;
+    CHECK_THROWS(batch_reduce(rpn, context, { "x", "y" }, rows.data(), 100, 1, sum));
+    CHECK_THROWS(batch_reduce(rpn, context, { "x", "y" }, rows.data(), 100, 1, sum, 4));
+
+    // readonly names cannot be bound
+    CHECK_THROWS(batch_reduce(rpn, context, { "x", "sin" }, rows.data(), 10, STRIDE, sum, 2));
+
+    // names the context does not have yet are bound, and the context itself is untouched
+    vector<token_t> z_rpn = compile<T>("x", context);
+    batch_reduce(z_rpn, context, { "x", "y", "z" }, rows.data(), 100, STRIDE, sum);
+    CHECK(sum.value() == T(4950));
+    CHECK_THROWS(context->get("z"));
+    CHECK(context->get("x").value == T(0));
+}
+
+template <typename T>
+void test_histogram_edges() {
+    histogram_t<T> histogram(0, 10, 5);
+
+    for (T x : { T(-1), T(0), T(1), T(2), T(9), T(10), T(11) })
+        histogram.push(x);
+
+    CHECK(histogram.underflow == 1);   // -1
+    CHECK(histogram.overflow == 2);    // 10 (upper bound is exclusive), 11
+    CHECK(histogram.bins[0] == 2);     // 0, 1
+    CHECK(histogram.bins[1] == 1);     // 2
+    CHECK(histogram.bins[4] == 1);     // 9
+
+    histogram_t<T> other(0, 10, 5);
+    other.push(T(5));
+    other.push(T(-5));
+    histogram.merge(other);
+
+    CHECK(histogram.bins[2] == 1 && histogram.underflow == 2);
+
+    histogram.clear();
+    CHECK(histogram.underflow == 0 && histogram.overflow == 0 && histogram.bins == vector<size_t>(5, 0));
+
+    CHECK_THROWS(histogram_t<T>(0, 10, 0));
+    CHECK_THROWS(histogram_t<T>(10, 10, 5));
+}
+
+/* past 2^24 a float sum of ones stops growing; past INT64_MAX an int64 sum would wrap */
+void test_accumulation() {
+    const size_t n = 20000000;
+
+    sum_t<float> sum;
+    mean_t<float> mean;
+    mean_t<float> halves[2];
+
+    for (size_t i = 0; i < n; ++i) {
+        sum.push(1.0f);
+        mean.push(1.0f);
+        halves[i % 2].push(1.0f);
+    }
+
+    halves[0].merge(halves[1]);
+
+    CHECK(sum.value() == float(n));
+    CHECK(mean.value() == 1.0f);
+    CHECK(halves[0].value() == 1.0f && halves[0].count == n);
+
+    // compensated summation keeps the small terms a plain double sum drops
+    sum_t<double> small;
+    small.push(1.0);
+
+    for (size_t i = 0; i < 10000000; ++i)
+        small.push(1e-16);
+
+    CHECK(std::abs(small.value() - (1.0 + 1e-9)) < 1e-15);
+
+    sum_t<int64_t> big;
+    big.push(numeric_limits<int64_t>::max());
+    CHECK_THROWS(big.push(1));
+
+    sum_t<int64_t> low, high;
+    low.push(numeric_limits<int64_t>::max() / 2 + 1);
+    high.push(numeric_limits<int64_t>::max() / 2 + 1);
+    CHECK_THROWS(low.merge(high));
+
+    mean_t<int64_t> big_mean;
+    big_mean.push(numeric_limits<int64_t>::min());
+    CHECK_THROWS(big_mean.push(-1));
+}
+
+template <typename T>
+void test_all() {
+    test_threads_agree<T>();
+    test_empty_rows<T>();
+    test_bindings<T>();
+    test_histogram_edges<T>();
+}
+
+int main() {
+    test_all<float>();
+    test_all<double>();
+    test_all<long double>();
+    test_all<int64_t>();
+
+    test_accumulation();
+
+    return check_report();
+}
@@ -0,0 +1,160 @@
+/*
+ * author: Luis Enrique Arias Curbelo
+ * repo:   https://github.com/larias95/shunting_yard
+ */
+
+#include <string>
+#include <vector>
+
+using namespace std;
+
+#include "check.hpp"
+#include "lexer.hpp"
+#include "my_context.hpp"
+#include "parser.hpp"
+
+using namespace sy;
+
+string define(const string& line, ParsingContext<double>* context) {
+    vector<token_t> tokens;
+    tokenize(line, tokens);
+    return define(tokens, context);
+}
+
+vector<token_t> compile(const string& line, const ParsingContext<double>* context) {
+    vector<token_t> tokens;
+    vector<token_t> rpn;
+
+    tokenize(line, tokens);
+    to_rpn(tokens, context, rpn);
+
+    return rpn;
+}
+
+double eval(const string& line, const ParsingContext<double>* context) {
+    vector<double> results;
+    rpn_eval(compile(line, context), context, results);
+    return results[0];
+}
+
+bool has_definitions(const vector<token_t>& rpn, const ParsingContext<double>* context) {
+    for (const token_t& token : rpn)
+        if (token.kind == token_t::kind_t::IDENTIFIER &&
+            context->get(token.text).content == entity_t<double>::content_t::DEFINITION)
+            return true;
+
+    return false;
+}
+
+void test_substitution() {
+    ParsingContext<double>* context = get_context<double>();
+
+    CHECK(define("g(a, b) = a - b", context) == "g");
+    define("h(a, b) = g(b, a)", context);
+    define("hypot(a, b) = sqrt(a^2 + b^2)", context);
+
+    CHECK(eval("g(10, 3)", context) == 7);
+    CHECK(eval("h(10, 3)", context) == -7);
+    CHECK(eval("h(2 * 5, 1 + 2) + g(1, h(4, 6))", context) == -8);
+    CHECK(eval("hypot(3, 4)", context) == 5);
+    CHECK(eval("hypot(hypot(3, 4), 12)", context) == 13);
+
+    CHECK(!has_definitions(compile("h(g(1, 2), hypot(3, 4))", context), context));
+}
+
+void test_zero_arity() {
+    ParsingContext<double>* context = get_context<double>();
+
+    define("two() = 1 + 1", context);
+    define("four() = two() * two()", context);
+
+    CHECK(eval("two()", context) == 2);
+    CHECK(eval("four() + two()", context) == 6);
+    CHECK(eval("max(four(), 3)", context) == 4);
+}
+
+void test_argument_count() {
+    ParsingContext<double>* context = get_context<double>();
+
+    define("g(a, b) = a - b", context);
+
+    CHECK_THROWS(eval("g(1)", context));
+    CHECK_THROWS(eval("g()", context));
+    CHECK_THROWS(eval("g(1, 2, 3)", context));
+}
+
+void test_invalid_definitions() {
+    ParsingContext<double>* context = get_context<double>();
+
+    CHECK_THROWS(define("sin(x) = x", context));     // readonly entity
+    CHECK_THROWS(define("f(x, x) = x", context));    // repeated parameter
+    CHECK_THROWS(define("f(f) = f", context));       // parameter named as the function
+    CHECK_THROWS(define("f(x) = x 1", context));     // malformed body
+    CHECK_THROWS(define("f(x) = y", context));       // unknown entity
+    CHECK_THROWS(define("f(x) =", context));         // empty body
+    CHECK_THROWS(define("f(x, ) = x", context));     // malformed parameters
+    CHECK_THROWS(define("1(x) = x", context));       // malformed name
+
+    // nothing was stored by the failed definitions
+    CHECK_THROWS(context->get("f"));
+}
+
+void test_late_binding() {
+    ParsingContext<double>* context = get_context<double>();
+
+    define("sq(x) = x * x", context);
+    define("quad(x) = sq(sq(x))", context);
+
+    CHECK(eval("quad(2)", context) == 16);
+
+    // a copy of the context shares the definitions it was made with
+    ParsingContext<double> snapshot(*context);
+
+    define("sq(x) = x * x * x", context);
+
+    CHECK(eval("quad(2)", context) == 512);
+    CHECK(eval("quad(2)", &snapshot) == 16);
+}
+
+void test_limits() {
+    ParsingContext<double>* context = get_context<double>();
+
+    // recursion is caught by the limits when declared, even with a growing argument
+    CHECK_THROWS(define("f(x) = f(x) + 1", context));
+    CHECK_THROWS(define("r(x) = r(x * x * x * x)", context));
+    CHECK_THROWS(context->get("r"));
+
+    // as is mutual recursion, closed by a redefinition, which leaves the old one in place
+    define("p(x) = x + 1", context);
+    define("q(x) = p(x) + 1", context);
+    CHECK_THROWS(define("p(x) = q(x) + 1", context));
+    CHECK(eval("q(1)", context) == 3);
+
+    // expansions doubling at every level are caught by the length limit
+    define("b(x) = x + x", context);
+    define("c(x) = b(b(b(b(b(b(b(b(b(b(x))))))))))", context);
+    CHECK(eval("c(1)", context) == 1024);
+
+    CHECK_THROWS(define("d(x) = c(c(x))", context));
+    CHECK_THROWS(eval("c(c(1))", context));
+
+    // the limit bounds what inlining adds, not the length of the expression
+    string sum = "1";
+
+    for (int i = 0; i < 33000; ++i)
+        sum += "+1";
+
+    CHECK(eval(sum, context) == 33001);
+    CHECK(eval(sum + "+c(1)", context) == 34025);
+}
+
+int main() {
+    test_substitution();
+    test_zero_arity();
+    test_argument_count();
+    test_invalid_definitions();
+    test_late_binding();
+    test_limits();
+
+    return check_report();
+}
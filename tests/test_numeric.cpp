@@ -0,0 +1,135 @@
+/*
+ * author: Luis Enrique Arias Curbelo
+ * repo:   https://github.com/larias95/shunting_yard
+ */
+
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+#include "check.hpp"
+#include "lexer.hpp"
+#include "my_context.hpp"
+#include "parser.hpp"
+
+using namespace sy;
+
+template <typename T>
+T eval(const string& line, const ParsingContext<T>* context) {
+    vector<token_t> tokens;
+    vector<token_t> rpn;
+    vector<T> results;
+
+    tokenize(line, tokens);
+    to_rpn(tokens, context, rpn);
+    rpn_eval(rpn, context, results);
+
+    return results[0];
+}
+
+/* exact for integral types, within a relative tolerance otherwise (e.g. 5! goes through tgamma) */
+template <typename T>
+bool same(T actual, T expected) {
+    if (numeric_limits<T>::is_integer)
+        return actual == expected;
+
+    return std::abs(actual - expected) <= std::abs(expected) * T(1e-5);
+}
+
+/* expressions every instantiation must agree on */
+template <typename T>
+void test_common() {
+    ParsingContext<T>* context = get_context<T>();
+
+    CHECK(same<T>(eval<T>("1 + 2 * 3", context), 7));
+    CHECK(same<T>(eval<T>("(1 + 2) * 3", context), 9));
+    CHECK(same<T>(eval<T>("2 ^ 3 ^ 2", context), 512));
+    CHECK(same<T>(eval<T>("5!", context), 120));
+    CHECK(same<T>(eval<T>("~4 + 10", context), 6));
+    CHECK(same<T>(eval<T>("max(3, 4) - min(3, 4)", context), 1));
+    CHECK(same<T>(eval<T>("abs(~7)", context), 7));
+    CHECK(same<T>(eval<T>("17 % 5", context), 2));
+    CHECK(same<T>(eval<T>("sqrt(16)", context), 4));
+
+    CHECK_THROWS(eval<T>("1 +", context));
+    CHECK_THROWS(eval<T>("unknown(1)", context));
+}
+
+template <typename T>
+void test_floating() {
+    ParsingContext<T>* context = get_context<T>();
+
+    CHECK(eval<T>("7 / 2", context) == T(3.5));
+    CHECK(eval<T>("0.25 * 4", context) == 1);
+    CHECK(eval<T>("7.5 % 2", context) == T(1.5));
+    CHECK(std::abs(eval<T>("2 ^ 0.5", context) - std::sqrt(T(2))) < T(1e-6));
+    CHECK(std::isinf(eval<T>("1 / 0", context)));
+    CHECK(eval<T>("pi", context) == static_cast<T>(3.141592653589793238462643383279502884L));
+
+    // real functions run on T itself, not through a wider type
+    CHECK(eval<T>("sin(1)", context) == std::sin(T(1)));
+    CHECK(eval<T>("exp(3)", context) == std::exp(T(3)));
+    CHECK(eval<T>("sqrt(2)", context) == std::sqrt(T(2)));
+    CHECK(eval<T>("2 _ 10", context) == std::log(T(10)) / std::log(T(2)));
+}
+
+void test_int64() {
+    ParsingContext<int64_t>* context = get_context<int64_t>();
+
+    CHECK(eval<int64_t>("7 / 2", context) == 3);
+    CHECK(eval<int64_t>("~7 % 3", context) == -1);
+    CHECK(eval<int64_t>("3 ^ 39", context) == 4052555153018976267LL);
+    CHECK(eval<int64_t>("9007199254740993 % 10", context) == 3);
+    CHECK(eval<int64_t>("9007199254740993 + 2", context) == 9007199254740995LL);
+    CHECK(eval<int64_t>("20!", context) == 2432902008176640000LL);
+    CHECK(eval<int64_t>("~9223372036854775807 - 1", context) == numeric_limits<int64_t>::min());
+
+    // irrational constants are not available
+    CHECK_THROWS(eval<int64_t>("pi * 2", context));
+    CHECK_THROWS(eval<int64_t>("e", context));
+    CHECK_THROWS(eval<int64_t>("max(phi, 1)", context));
+
+    // literals
+    CHECK_THROWS(eval<int64_t>("1.5", context));
+    CHECK_THROWS(eval<int64_t>("2 ^ 0.5", context));
+
+    // division
+    CHECK_THROWS(eval<int64_t>("1 / 0", context));
+    CHECK_THROWS(eval<int64_t>("1 % 0", context));
+    CHECK_THROWS(eval<int64_t>("(~9223372036854775807 - 1) / ~1", context));
+    CHECK_THROWS(eval<int64_t>("(~9223372036854775807 - 1) % ~1", context));
+
+    // overflow
+    CHECK_THROWS(eval<int64_t>("9223372036854775807 + 1", context));
+    CHECK_THROWS(eval<int64_t>("~9223372036854775807 - 2", context));
+    CHECK_THROWS(eval<int64_t>("4294967296 * 4294967296", context));
+    CHECK_THROWS(eval<int64_t>("~(~9223372036854775807 - 1)", context));
+    CHECK_THROWS(eval<int64_t>("abs(~9223372036854775807 - 1)", context));
+    CHECK_THROWS(eval<int64_t>("3 ^ 40", context));
+    CHECK_THROWS(eval<int64_t>("21!", context));
+    CHECK_THROWS(eval<int64_t>("exp(100)", context));
+    CHECK_THROWS(eval<int64_t>("log(0)", context));
+
+    // domain
+    CHECK_THROWS(eval<int64_t>("2 ^ ~1", context));
+    CHECK_THROWS(eval<int64_t>("(~1)!", context));
+}
+
+int main() {
+    test_common<float>();
+    test_common<double>();
+    test_common<long double>();
+    test_common<int64_t>();
+
+    test_floating<float>();
+    test_floating<double>();
+    test_floating<long double>();
+
+    test_int64();
+
+    return check_report();
+}
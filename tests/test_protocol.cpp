@@ -0,0 +1,119 @@
+/*
+ * author: Luis Enrique Arias Curbelo
+ * repo:   https://github.com/larias95/shunting_yard
+ */
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+using namespace std;
+
+#include "check.hpp"
+#include "protocol.hpp"
+
+void test_single_frame() {
+    string buffer;
+    append_request(buffer, 42, "1 + 2");
+
+    CHECK(buffer.size() == 2 * sizeof(uint32_t) + 5);
+
+    size_t offset = 0;
+    uint32_t id = 0;
+    string body;
+
+    CHECK(next_frame(buffer, offset, id, body));
+    CHECK(id == 42 && body == "1 + 2" && offset == buffer.size());
+    CHECK(!next_frame(buffer, offset, id, body));
+}
+
+void test_partial_frames() {
+    string buffer;
+    append_request(buffer, 7, "sqrt(2)");
+
+    // no proper prefix of a frame is a frame, and nothing is consumed
+    for (size_t length = 0; length < buffer.size(); ++length) {
+        string prefix = buffer.substr(0, length);
+        size_t offset = 0;
+        uint32_t id;
+        string body;
+
+        CHECK(!next_frame(prefix, offset, id, body));
+        CHECK(offset == 0);
+    }
+}
+
+void test_several_frames() {
+    string buffer;
+    append_request(buffer, 1, "a");
+    append_request(buffer, 2, "");
+    append_request(buffer, 3, "ccc");
+    append_request(buffer, 4, "dddd");
+    buffer.resize(buffer.size() - 1);
+
+    size_t offset = 0;
+    uint32_t id;
+    string body;
+
+    CHECK(next_frame(buffer, offset, id, body) && id == 1 && body == "a");
+    CHECK(next_frame(buffer, offset, id, body) && id == 2 && body == "");
+    CHECK(next_frame(buffer, offset, id, body) && id == 3 && body == "ccc");
+    CHECK(!next_frame(buffer, offset, id, body));
+
+    buffer.push_back('d');
+    CHECK(next_frame(buffer, offset, id, body) && id == 4 && body == "dddd");
+    CHECK(offset == buffer.size());
+}
+
+void test_invalid_lengths() {
+    size_t offset = 0;
+    uint32_t id;
+    string body;
+
+    // shorter than the id it must carry
+    string too_short;
+    append_u32(too_short, 2);
+    append_u32(too_short, 0);
+    CHECK_THROWS(next_frame(too_short, offset, id, body));
+
+    // longer than any frame either side accepts, rejected from its header alone
+    string too_long;
+    append_u32(too_long, MAX_FRAME_LENGTH + 1);
+    append_u32(too_long, 0);
+    CHECK_THROWS(next_frame(too_long, offset, id, body));
+
+    // the longest accepted frame
+    string longest;
+    append_request(longest, 9, string(MAX_FRAME_LENGTH - sizeof(uint32_t), '1'));
+    CHECK(next_frame(longest, offset, id, body) && id == 9 && body.size() == MAX_FRAME_LENGTH - sizeof(uint32_t));
+}
+
+void test_responses() {
+    string buffer;
+    append_response(buffer, 5, 2.5);
+    append_error(buffer, 6, "Invalid token.");
+
+    size_t offset = 0;
+    uint32_t id;
+    string body;
+
+    CHECK(next_frame(buffer, offset, id, body) && id == 5);
+    CHECK(body.size() == 1 + sizeof(double) && uint8_t(body[0]) == STATUS_OK);
+
+    double value;
+    memcpy(&value, body.data() + 1, sizeof(value));
+    CHECK(value == 2.5);
+
+    CHECK(next_frame(buffer, offset, id, body) && id == 6);
+    CHECK(uint8_t(body[0]) == STATUS_ERROR && body.substr(1) == "Invalid token.");
+}
+
+int main() {
+    test_single_frame();
+    test_partial_frames();
+    test_several_frames();
+    test_invalid_lengths();
+    test_responses();
+
+    return check_report();
+}
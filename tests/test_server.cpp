@@ -0,0 +1,257 @@
+/*
+ * author: Luis Enrique Arias Curbelo
+ * repo:   https://github.com/larias95/shunting_yard
+ */
+
+#include <cerrno>
+#include <csignal>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <string>
+
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+using namespace std;
+
+#include "check.hpp"
+#include "protocol.hpp"
+
+/*
+ * Round trip against the server executable given as argv[1]: it is started on
+ * a socket in a fresh directory, fed pipelined requests and stopped with
+ * SIGTERM, and its final "served ... with ... evaluations" line is checked.
+ */
+
+struct server_t {
+    pid_t pid;
+    int   errors; // read end of the server's stderr
+};
+
+server_t start_server(const string& executable, const string& path) {
+    int pipe_fds[2];
+
+    if (pipe(pipe_fds) < 0) {
+        perror("pipe");
+        exit(1);
+    }
+
+    pid_t pid = fork();
+
+    if (pid == 0) {
+        dup2(pipe_fds[1], STDERR_FILENO);
+        close(pipe_fds[0]);
+        close(pipe_fds[1]);
+        execl(executable.c_str(), executable.c_str(), path.c_str(), (char*)NULL);
+        _exit(127);
+    }
+
+    close(pipe_fds[1]);
+    return server_t { pid, pipe_fds[0] };
+}
+
+// Stops the server and returns its exit status and everything it wrote to stderr.
+int stop_server(server_t& server, string& errors) {
+    kill(server.pid, SIGTERM);
+
+    int status = 0;
+    waitpid(server.pid, &status, 0);
+
+    char chunk[4096];
+    ssize_t count;
+
+    while ((count = read(server.errors, chunk, sizeof(chunk))) > 0)
+        errors.append(chunk, count);
+
+    close(server.errors);
+    return WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+}
+
+int connect_to(const string& path) {
+    sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    strcpy(address.sun_path, path.c_str());
+
+    // the server may still be starting
+    for (int attempt = 0; attempt < 200; ++attempt) {
+        int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+
+        if (connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == 0)
+            return fd;
+
+        close(fd);
+        usleep(10 * 1000);
+    }
+
+    return -1;
+}
+
+void send_all(int fd, const string& buffer) {
+    size_t offset = 0;
+
+    while (offset < buffer.size()) {
+        ssize_t count = send(fd, buffer.data() + offset, buffer.size() - offset, MSG_NOSIGNAL);
+
+        if (count <= 0)
+            return;
+
+        offset += count;
+    }
+}
+
+// Reads `expected` responses, or until the server closes the connection.
+map<uint32_t, string> receive(int fd, size_t expected) {
+    map<uint32_t, string> responses;
+    string input;
+    char chunk[4096];
+
+    while (responses.size() < expected) {
+        ssize_t count = recv(fd, chunk, sizeof(chunk), 0);
+
+        if (count <= 0)
+            break;
+
+        input.append(chunk, count);
+
+        size_t offset = 0;
+        uint32_t id;
+        string body;
+
+        while (next_frame(input, offset, id, body))
+            responses[id] = body;
+
+        input.erase(0, offset);
+    }
+
+    return responses;
+}
+
+double value_of(const string& body) {
+    double value;
+    memcpy(&value, body.data() + 1, sizeof(value));
+    return value;
+}
+
+bool is_ok(const string& body, double expected) {
+    return body.size() == 1 + sizeof(double) && uint8_t(body[0]) == STATUS_OK && value_of(body) == expected;
+}
+
+bool is_error(const string& body) {
+    return !body.empty() && uint8_t(body[0]) == STATUS_ERROR;
+}
+
+bool is_closed(int fd) {
+    char byte;
+    return recv(fd, &byte, 1, 0) == 0;
+}
+
+void test_refuses_regular_file(const string& executable, const string& directory) {
+    string path = directory + "/regular";
+    FILE* file = fopen(path.c_str(), "w");
+    fputs("keep me", file);
+    fclose(file);
+
+    server_t server = start_server(executable, path);
+    int status = 0;
+    waitpid(server.pid, &status, 0);
+    close(server.errors);
+
+    struct stat info;
+
+    CHECK(WIFEXITED(status) && WEXITSTATUS(status) == 1);
+    CHECK(lstat(path.c_str(), &info) == 0 && S_ISREG(info.st_mode));
+
+    unlink(path.c_str());
+}
+
+void test_round_trip(const string& executable, const string& directory) {
+    string path = directory + "/server.sock";
+    server_t server = start_server(executable, path);
+
+    int fd = connect_to(path);
+    CHECK(fd >= 0);
+
+    if (fd < 0) {
+        string errors;
+        stop_server(server, errors);
+        return;
+    }
+
+    // 30 pipelined requests over 3 distinct expressions, sent at once
+    const char* expressions[] = { "1 + 2 * 3", "2 ^ 10", "max(4, 9) - 1" };
+    const double values[] = { 7, 1024, 8 };
+
+    string output;
+
+    for (uint32_t id = 0; id < 30; ++id)
+        append_request(output, id, expressions[id % 3]);
+
+    append_request(output, 30, "1 +");
+    append_request(output, 31, string(MAX_EXPRESSION_LENGTH + 1, '1'));
+    send_all(fd, output);
+
+    map<uint32_t, string> responses = receive(fd, 32);
+    CHECK(responses.size() == 32);
+
+    for (uint32_t id = 0; id < 30; ++id)
+        CHECK(is_ok(responses[id], values[id % 3]));
+
+    CHECK(is_error(responses[30]));
+    CHECK(is_error(responses[31]));
+
+    close(fd);
+
+    // a frame longer than MAX_FRAME_LENGTH is refused from its header
+    fd = connect_to(path);
+    output.clear();
+    append_u32(output, MAX_FRAME_LENGTH + 1);
+    append_u32(output, 0);
+    send_all(fd, output);
+    CHECK(is_closed(fd));
+    close(fd);
+
+    // so is one too short to carry an id
+    fd = connect_to(path);
+    output.clear();
+    append_u32(output, 2);
+    append_u32(output, 0);
+    send_all(fd, output);
+    CHECK(is_closed(fd));
+    close(fd);
+
+    string errors;
+    CHECK(stop_server(server, errors) == 0);
+
+    // every request was answered, each distinct expression evaluated once
+    CHECK(errors.find("served 32 requests with 5 evaluations") != string::npos);
+
+    struct stat info;
+    CHECK(lstat(path.c_str(), &info) < 0 && errno == ENOENT);
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        cerr << "usage: " << argv[0] << " <server executable>" << endl;
+        return 1;
+    }
+
+    char directory[] = "/tmp/shunting_yard_XXXXXX";
+
+    if (mkdtemp(directory) == NULL) {
+        perror("mkdtemp");
+        return 1;
+    }
+
+    test_refuses_regular_file(argv[1], directory);
+    test_round_trip(argv[1], directory);
+
+    rmdir(directory);
+    return check_report();
+}